@@ -0,0 +1,91 @@
+#include "concurrent_dict.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using ConcurrentDict = cppdict::ConcurrentDict<int, double, std::string>;
+using Dict           = ConcurrentDict::dict_t;
+
+namespace
+{
+Dict make_config()
+{
+    Dict dict;
+    for (int i = 0; i < 100; ++i)
+        for (int j = 0; j < 10; ++j)
+            dict["section" + std::to_string(i)]["param" + std::to_string(j)] = i * j;
+    return dict;
+}
+
+// A section reloaded as a whole.
+Dict const& reloaded_section()
+{
+    static Dict const section = [] {
+        Dict dict;
+        for (int j = 0; j < 1000; ++j)
+            dict["param" + std::to_string(j)] = j;
+        return dict;
+    }();
+    return section;
+}
+
+// Benchmark threads only read while a background writer keeps updating the configuration.
+template<typename Update, typename Read>
+void run_reads_during_updates(benchmark::State& state, Update&& update, Read&& read)
+{
+    static std::atomic<bool> stop;
+    static std::thread writer;
+    if (state.thread_index() == 0)
+    {
+        stop   = false;
+        writer = std::thread{[&update] {
+            for (int i = 0; !stop; ++i)
+                update(i);
+        }};
+    }
+    for (auto _ : state)
+        benchmark::DoNotOptimize(read());
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        stop = true;
+        writer.join();
+    }
+}
+
+void BM_concurrent_dict_reads(benchmark::State& state)
+{
+    static ConcurrentDict cdict{make_config()};
+    run_reads_during_updates(
+        state,
+        [](int) { cdict.update("section42", [](Dict& node) { node = reloaded_section(); }); },
+        [] { return (*cdict.snapshot())["section7"]["param3"].to<int>(); });
+}
+
+// Same workload with a plain Dict behind a global mutex, readers wait while a section is
+// copied in.
+void BM_mutex_dict_reads(benchmark::State& state)
+{
+    static Dict dict = make_config();
+    static std::mutex mutex;
+    run_reads_during_updates(
+        state,
+        [](int) {
+            std::lock_guard<std::mutex> lock{mutex};
+            dict["section42"] = reloaded_section();
+        },
+        [] {
+            std::lock_guard<std::mutex> lock{mutex};
+            return dict["section7"]["param3"].to<int>();
+        });
+}
+} // namespace
+
+BENCHMARK(BM_concurrent_dict_reads)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_mutex_dict_reads)->ThreadRange(1, 16)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#include "shared_dict.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <unistd.h>
+
+using Dict       = cppdict::Dict<int, double, std::string>;
+using SharedDict = cppdict::SharedDict<int, double, std::string>;
+
+namespace
+{
+Dict make_config(int sections)
+{
+    Dict dict;
+    for (int i = 0; i < sections; ++i)
+        for (int j = 0; j < 10; ++j)
+            dict["section" + std::to_string(i)]["param" + std::to_string(j)] = i * j;
+    return dict;
+}
+
+// Attaching maps the segment, it doesn't depend on the dict size.
+void BM_shared_dict_attach(benchmark::State& state)
+{
+    auto const name = "/cppdict_bench_" + std::to_string(::getpid());
+    auto owner      = SharedDict::create(name, make_config(static_cast<int>(state.range(0))));
+    for (auto _ : state)
+    {
+        auto attached = SharedDict::attach(name);
+        benchmark::DoNotOptimize(attached.root()["section0"]["param0"].to<int>());
+    }
+}
+
+void BM_shared_dict_lookup(benchmark::State& state)
+{
+    auto const name = "/cppdict_bench_" + std::to_string(::getpid());
+    auto owner      = SharedDict::create(name, make_config(static_cast<int>(state.range(0))));
+    auto attached   = SharedDict::attach(name);
+    auto const root = attached.root();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(root["section7"]["param3"].to<int>());
+}
+
+void BM_dict_lookup(benchmark::State& state)
+{
+    auto const dict = make_config(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(dict["section7"]["param3"].to<int>());
+}
+} // namespace
+
+BENCHMARK(BM_shared_dict_attach)->Range(10, 10000);
+BENCHMARK(BM_shared_dict_lookup)->Range(10, 10000);
+BENCHMARK(BM_dict_lookup)->Range(10, 10000);
+
+BENCHMARK_MAIN();
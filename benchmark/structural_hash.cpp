@@ -0,0 +1,61 @@
+#include "dict.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <iterator>
+#include <string>
+
+using Dict = cppdict::Dict<int, double, std::string>;
+
+namespace
+{
+Dict make_tree(int width)
+{
+    Dict dict;
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < width; ++j)
+            dict["node" + std::to_string(i)]["param" + std::to_string(j)] = i * j;
+    return dict;
+}
+
+// Rehashing after a single change only walks the modified path.
+void BM_hash_after_change(benchmark::State& state)
+{
+    auto dict = make_tree(static_cast<int>(state.range(0)));
+    dict.hash();
+    int i = 0;
+    for (auto _ : state)
+    {
+        dict["node0"]["param0"] = ++i;
+        benchmark::DoNotOptimize(dict.hash());
+    }
+}
+
+// The mismatch is on the last value compared, cached hashes tell the trees differ at once.
+void BM_compare_different(benchmark::State& state)
+{
+    auto const lhs  = make_tree(static_cast<int>(state.range(0)));
+    auto rhs        = make_tree(static_cast<int>(state.range(0)));
+    auto& last_node = *std::prev(std::end(rhs))->second;
+
+    *std::prev(std::end(last_node))->second = -1;
+    lhs.hash();
+    rhs.hash();
+    for (auto _ : state)
+        benchmark::DoNotOptimize(lhs == rhs);
+}
+
+void BM_compare_equal(benchmark::State& state)
+{
+    auto const lhs = make_tree(static_cast<int>(state.range(0)));
+    auto const rhs = make_tree(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+        benchmark::DoNotOptimize(lhs == rhs);
+}
+} // namespace
+
+BENCHMARK(BM_hash_after_change)->Range(8, 256);
+BENCHMARK(BM_compare_different)->Range(8, 256);
+BENCHMARK(BM_compare_equal)->Range(8, 256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,88 @@
+#include "dict.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <string>
+
+using Dict = cppdict::Dict<int, double, std::string>;
+
+namespace
+{
+Dict make_tree(int width)
+{
+    Dict dict;
+    for (int i = 0; i < width; ++i)
+        for (int j = 0; j < width; ++j)
+        {
+            dict["node" + std::to_string(i)]["int" + std::to_string(j)]    = i * j;
+            dict["node" + std::to_string(i)]["double" + std::to_string(j)] = 1. * i * j;
+        }
+    return dict;
+}
+
+// Visitors with a large capture, as when holding some state or a lookup table.
+std::array<double, 64> const weights{};
+
+void BM_visit_leaves(benchmark::State& state)
+{
+    auto const dict = make_tree(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        double sum = 0;
+        dict.visit_leaves(
+            [&sum, weights = weights](const std::string&, int v) { sum += v * weights[0]; },
+            [&sum](const std::string&, double v) { sum += v; },
+            [](const std::string&, const auto&) {});
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+void BM_walk_leaves(benchmark::State& state)
+{
+    auto const dict = make_tree(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        double sum = 0;
+        dict.walk(
+            [&sum, weights = weights](const std::string&, int v) { sum += v * weights[0]; },
+            [&sum](const std::string&, double v) { sum += v; },
+            [](const std::string&, const auto&) {});
+        benchmark::DoNotOptimize(sum);
+    }
+}
+
+// Only visiting the first level: visit() vs walk() skipping every subtree.
+void BM_visit_children(benchmark::State& state)
+{
+    auto const dict = make_tree(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::size_t count = 0;
+        dict.visit(cppdict::visit_all_nodes,
+                   [&count](const std::string&, const auto&) { count++; });
+        benchmark::DoNotOptimize(count);
+    }
+}
+
+void BM_walk_children(benchmark::State& state)
+{
+    auto const dict = make_tree(static_cast<int>(state.range(0)));
+    for (auto _ : state)
+    {
+        std::size_t count = 0;
+        dict.walk(cppdict::visit_all_nodes, [&count](const std::string&, const auto&) {
+            count++;
+            return cppdict::visit_action::skip;
+        });
+        benchmark::DoNotOptimize(count);
+    }
+}
+} // namespace
+
+BENCHMARK(BM_visit_leaves)->Range(8, 256);
+BENCHMARK(BM_walk_leaves)->Range(8, 256);
+BENCHMARK(BM_visit_children)->Range(8, 256);
+BENCHMARK(BM_walk_children)->Range(8, 256);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,259 @@
+#ifndef CONCURRENT_DICT_H
+#define CONCURRENT_DICT_H
+
+#include "dict.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cppdict
+{
+/// Dict shared between threads: readers take an immutable snapshot of the whole tree without
+/// taking any lock, writers publish a new version of the tree which shares every subtree that
+/// was not modified with the previous one (RCU style). Old versions are reclaimed when the
+/// last reader holding them drops its snapshot.
+///
+/// The current version is reached through an atomic raw pointer guarded by hazard pointers,
+/// a reader only retries when a writer published in between, then copies the shared_ptr.
+/// Beyond hazard_slots concurrent snapshot() calls, the extra readers spin until a slot is
+/// released.
+template<typename... Types>
+class ConcurrentDict
+{
+public:
+    using dict_t     = Dict<Types...>;
+    using snapshot_t = std::shared_ptr<const dict_t>;
+
+    static constexpr std::size_t hazard_slots = 64;
+
+    ConcurrentDict()
+        : current_{new tree_version_t{published_(std::make_shared<dict_t>())}}
+    {
+    }
+
+    explicit ConcurrentDict(dict_t dict)
+        : current_{new tree_version_t{published_(std::make_shared<dict_t>(std::move(dict)))}}
+    {
+    }
+
+    ConcurrentDict(ConcurrentDict const&) = delete;
+    ConcurrentDict& operator=(ConcurrentDict const&) = delete;
+
+    ~ConcurrentDict()
+    {
+        delete current_.load();
+        for (auto retired : retired_)
+            delete retired;
+    }
+
+    /// Nodes reachable from a snapshot may be shared with other versions, they must only be
+    /// read through const references. Their parent links are cleared on publication so
+    /// writes through const_cast or iterators aren't tracked.
+    /// Copy the snapshot (or a subtree of it) to get a mutable Dict.
+    snapshot_t snapshot() const
+    {
+        auto& hazard = acquire_hazard_();
+        auto current = current_.load();
+        hazard.store(current);
+        for (auto again = current_.load(); again != current; again = current_.load())
+        {
+            current = again;
+            hazard.store(current);
+        }
+        snapshot_t root = current->root;
+        hazard.store(nullptr, std::memory_order_release);
+        return root;
+    }
+
+    /// Applies fn to a private copy of the node at `keys` and publishes the new tree.
+    /// Only the nodes along `keys` and the target subtree are copied. Missing keys are
+    /// created as with Dict::operator[].
+    template<typename Fn>
+    void update(std::vector<std::string> const& keys, Fn&& fn)
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex_};
+        auto root = shallow_copy_(*current_.load()->root);
+
+        dict_t* node = root.get();
+        for (auto const& key : keys)
+            node = &copy_child_(*node, key, &key == &keys.back());
+        if (keys.empty())
+            root->copy_data_();
+
+        std::forward<Fn>(fn)(*node);
+        publish_(published_(std::move(root)));
+    }
+
+    template<typename Fn>
+    void update(std::string const& path, Fn&& fn)
+    {
+        update(detail::split_string(path), std::forward<Fn>(fn));
+    }
+
+    template<typename T, typename Check = std::enable_if_t<is_any_of<std::decay_t<T>, Types...>()>>
+    void add(std::string const& path, T&& value)
+    {
+        update(path, [&value](dict_t& node) { node = std::forward<T>(value); });
+    }
+
+    /// Publishes a whole new tree, nothing is shared with the previous version. The new tree
+    /// is stamped above the previous version, as if it had been assigned to the root.
+    void reset(dict_t dict)
+    {
+        std::lock_guard<std::mutex> lock{writer_mutex_};
+        auto root        = std::make_shared<dict_t>(std::move(dict));
+        auto const stamp = current_.load()->root->version_ + 1;
+        root->stamp_subtree_(stamp);
+        root->replaced_version_ = stamp;
+        publish_(published_(std::move(root)));
+    }
+
+    /// Publishes a version of the tree where identical subtrees, found by their structural
+    /// hash, are shared. A shared node gets the latest version of the subtrees it replaces,
+    /// so changed_since() never misses a change, though it may report spurious ones.
+    void deduplicate()
+    {
+        static_assert(dict_t::is_hashable, "cppdict: deduplicate() needs hashable Types...");
+        std::lock_guard<std::mutex> lock{writer_mutex_};
+        pool_t pool;
+        publish_(intern_(*current_.load()->root, pool));
+    }
+
+private:
+    using pool_t = std::unordered_multimap<std::size_t, std::shared_ptr<dict_t>>;
+
+    struct tree_version_t
+    {
+        snapshot_t root;
+    };
+    struct alignas(64) hazard_t
+    {
+        std::atomic<tree_version_t const*> version = nullptr;
+    };
+    // marks a hazard slot taken by a reader which didn't load the current version yet
+    static inline tree_version_t const reserved_{};
+
+    std::atomic<tree_version_t const*> current_;
+    mutable std::array<hazard_t, hazard_slots> hazards_;
+    std::vector<tree_version_t const*> retired_; // guarded by writer_mutex_
+    std::mutex writer_mutex_;
+
+    std::atomic<tree_version_t const*>& acquire_hazard_() const
+    {
+        static std::atomic<std::size_t> thread_count = 0;
+        static thread_local std::size_t const first  = thread_count++;
+        for (auto slot = first;; ++slot)
+        {
+            auto& hazard                = hazards_[slot % hazard_slots].version;
+            tree_version_t const* empty = nullptr;
+            if (!hazard.load(std::memory_order_relaxed)
+                and hazard.compare_exchange_weak(empty, &reserved_, std::memory_order_acquire))
+                return hazard;
+        }
+    }
+
+    // A reader stores the version it loaded in its hazard slot before checking it is still
+    // current, so a retired version absent from every slot can't be reached anymore.
+    void publish_(snapshot_t root)
+    {
+        retired_.push_back(current_.exchange(new tree_version_t{std::move(root)}));
+
+        std::array<tree_version_t const*, hazard_slots> in_use;
+        std::transform(std::begin(hazards_), std::end(hazards_), std::begin(in_use),
+                       [](hazard_t const& hazard) { return hazard.version.load(); });
+        auto const unused = std::partition(
+            std::begin(retired_), std::end(retired_), [&in_use](tree_version_t const* retired) {
+                return std::find(std::begin(in_use), std::end(in_use), retired) != std::end(in_use);
+            });
+        for (auto retired = unused; retired != std::end(retired_); ++retired)
+            delete *retired;
+        retired_.erase(unused, std::end(retired_));
+    }
+
+    // Hashes are computed before publication so that readers never write the hash cache.
+    // Parent links are cleared since shared nodes outlive the version they point into.
+    static snapshot_t published_(std::shared_ptr<dict_t> root)
+    {
+        clear_parents_(*root);
+        if constexpr (dict_t::is_hashable)
+            root->hash();
+        return root;
+    }
+
+    // nodes shared with published versions already have no parent, they are not walked
+    static void clear_parents_(dict_t& node)
+    {
+        if (node.isNode())
+            for (auto const& [_, child] : std::get<typename dict_t::node_t>(node.data))
+                if (child->parent_)
+                {
+                    child->parent_ = nullptr;
+                    clear_parents_(*child);
+                }
+    }
+
+    static std::shared_ptr<dict_t> shallow_copy_(dict_t const& node)
+    {
+        auto copy             = std::make_shared<dict_t>();
+        copy->data              = node.data;
+        copy->version_          = node.version_;
+        copy->hash_             = node.hash_;
+        copy->hashed_version_   = node.hashed_version_;
+        copy->replaced_version_ = node.replaced_version_;
+        return copy;
+    }
+
+    // Replaces parent[key] by a copy, shallow on the path so siblings are shared with the
+    // previous version, deep for the last key since it is handed to the writer.
+    static dict_t& copy_child_(dict_t& parent, std::string const& key, bool deep)
+    {
+        if (!parent.contains(key))
+            return parent[key];
+
+        auto& child = std::get<typename dict_t::node_t>(parent.data)[key];
+        auto copy     = deep ? std::make_shared<dict_t>(*child) : shallow_copy_(*child);
+        copy->parent_ = &parent;
+        child         = std::move(copy);
+        return *child;
+    }
+
+    // Children are interned first so equal subtrees compare by address. Pooled nodes are
+    // copies owned by this pass, so their version can still be raised to the latest version
+    // of the subtrees they replace before being published.
+    static std::shared_ptr<dict_t> intern_(dict_t const& node, pool_t& pool)
+    {
+        auto interned = shallow_copy_(node);
+        if (node.isNode())
+        {
+            typename dict_t::node_t children;
+            for (auto const& [key, child] : std::get<typename dict_t::node_t>(node.data))
+                children.emplace_hint(std::end(children), key, intern_(*child, pool));
+            interned->data = std::move(children);
+        }
+        auto const hash    = interned->hash();
+        auto [first, last] = pool.equal_range(hash);
+        for (auto it = first; it != last; ++it)
+        {
+            auto& shared = *it->second;
+            if (shared == *interned)
+            {
+                shared.version_        = std::max(shared.version_, interned->version_);
+                shared.hashed_version_ = shared.version_;
+                return it->second;
+            }
+        }
+        pool.emplace(hash, interned);
+        return interned;
+    }
+};
+
+} // namespace cppdict
+#endif
@@ -3,8 +3,10 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <map>
 #include <memory>
 #include <optional>
@@ -25,8 +27,32 @@ namespace
     {
         return std::disjunction_v<std::is_same<T1, T2>...>;
     }
+
+    constexpr std::size_t hash_combine(std::size_t seed, std::size_t hash) noexcept
+    {
+        return seed ^ (hash + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
 } // namespace
 
+/// Hash of user values used by Dict::hash(), specialize it for types without std::hash.
+template<typename T>
+struct value_hash : std::hash<T>
+{
+};
+
+template<typename T>
+inline constexpr bool is_hashable_v
+    = std::is_default_constructible_v<value_hash<T>>
+      and std::is_invocable_r_v<std::size_t, const value_hash<T>&, const T&>;
+
+/// What walk() does after a visitor returns, visitors returning void always continue.
+enum class visit_action {
+    next,     // continue, descending into this child if it is a node
+    skip,     // continue without descending into this child
+    stop,     // end the walk
+    modified, // like next, and marks the child as modified for change tracking
+};
+
 namespace // Visitor details
 {
     struct values_only_t
@@ -80,9 +106,12 @@ namespace // Visitor details
                     std::visit(
                         [key, lambdas...](auto&& value) {
                             using T = std::decay_t<decltype(value)>;
-                            if constexpr (NodeT::template is_value_v<
-                                              T> or !is_values_only_v<visit_policy_t>)
+                            // only values of a non const node are given by mutable reference
+                            if constexpr (NodeT::template is_value_v<T> and !std::is_const_v<NodeT>)
                                 make_visitor(lambdas...)(key, value);
+                            else if constexpr (NodeT::template is_value_v<
+                                                   T> or !is_values_only_v<visit_policy_t>)
+                                make_visitor(lambdas...)(key, std::as_const(value));
                         },
                         child_node->data);
                 }
@@ -91,6 +120,55 @@ namespace // Visitor details
         else
             throw std::runtime_error("cppdict: can only visit node");
     }
+
+    // visitors returning void get `by_default`
+    template<visit_action by_default = visit_action::next, typename VisitorT, typename ValueT>
+    visit_action invoke_visitor(VisitorT& visitor, const std::string& key, ValueT& value)
+    {
+        if constexpr (std::is_same_v<decltype(visitor(key, value)), visit_action>)
+            return visitor(key, value);
+        else
+        {
+            visitor(key, value);
+            return by_default;
+        }
+    }
+
+    struct const_probe_tag
+    {
+    };
+
+    // Hides the visitor's overload taking a const T&, if any, so a call with a T& only
+    // resolves to one of the visitor's overloads when it prefers a mutable reference.
+    template<typename VisitorT, typename T>
+    struct const_probe : VisitorT
+    {
+        using VisitorT::operator();
+        const_probe_tag operator()(const std::string&, const T&) const;
+    };
+
+    template<typename VisitorT, typename T>
+    constexpr bool takes_mutable_value()
+    {
+        using visitor_t = std::remove_const_t<VisitorT>;
+        if constexpr (std::is_class_v<visitor_t> and !std::is_final_v<visitor_t>)
+        {
+            using probe_t = const_probe<visitor_t, T>;
+            // ambiguous with an overload taking T by value
+            if constexpr (!std::is_invocable_v<probe_t&, const std::string&, T&>)
+                return false;
+            else
+                return !std::is_same_v<std::invoke_result_t<probe_t&, const std::string&, T&>,
+                                       const_probe_tag>;
+        }
+        else
+            return !std::is_invocable_v<VisitorT&, const std::string&, const T&>;
+    }
+
+    struct keep_all_t
+    {
+        bool operator()(const std::string&) const noexcept { return true; }
+    };
 } // namespace
 
 constexpr values_only_t visit_values_only;
@@ -103,6 +181,7 @@ struct Dict
     using empty_leaf_t = std::monostate;
     using node_t       = std::map<std::string, node_ptr>;
     using data_t       = std::variant<empty_leaf_t, node_t, Types...>;
+    using version_t    = std::uint64_t;
 
     template<typename T>
     struct is_value
@@ -113,27 +192,54 @@ struct Dict
     template<typename T>
     static constexpr bool is_value_v = is_value<T>::value;
 
+    static constexpr bool is_hashable = (is_hashable_v<Types> and ...);
+
 
     data_t data = empty_leaf_t{};
 #ifndef NDEBUG
-    static inline std::string currentKey;
+    static inline thread_local std::string currentKey;
 #endif
 
-    Dict()       = default;
-    Dict(Dict&&) = default;
+    Dict() = default;
+    Dict(Dict&& other) noexcept(std::is_nothrow_move_constructible_v<data_t>)
+        : data{std::move(other.data)}
+        , version_{other.version_}
+        , hash_{other.hash_}
+        , hashed_version_{other.hashed_version_}
+        , replaced_version_{other.replaced_version_}
+    {
+        this->adopt_children_();
+        other.moved_from_();
+    }
     Dict(const Dict& other)
         : data{other.data}
+        , version_{other.version_}
+        , hash_{other.hash_}
+        , hashed_version_{other.hashed_version_}
+        , replaced_version_{other.replaced_version_}
     {
         this->copy_data_();
     }
 
     Dict& operator=(const Dict& other)
     {
+        this->copy_hash_(other);
         this->data = other.data;
         this->copy_data_();
+        this->mark_subtree_modified_();
+        return *this;
+    }
+    Dict& operator=(Dict&& other) noexcept(std::is_nothrow_move_assignable_v<data_t>)
+    {
+        if (this == &other)
+            return *this;
+        this->copy_hash_(other);
+        this->data = std::move(other.data);
+        this->adopt_children_();
+        this->mark_subtree_modified_();
+        other.moved_from_();
         return *this;
     }
-    Dict& operator=(Dict&& other) = default;
 
     Dict& operator[](const std::string& key)
     {
@@ -147,25 +253,22 @@ struct Dict
 
             if (std::end(map) == map.find(key))
             {
-                map[key] = std::make_shared<Dict>();
+                return this->insert_child_(key);
             }
 
             return *std::get<node_t>(data)[key];
         }
         else if (isEmpty())
         {
-            data      = node_t{};
-            auto& map = std::get<node_t>(data);
-            map[key]  = std::make_shared<Dict>();
-
-            return *std::get<node_t>(data)[key];
+            data = node_t{};
+            return this->insert_child_(key);
         }
 
         throw std::runtime_error("cppdict: invalid key: " + key);
     }
 
 
-    Dict& operator[](const std::string& key) const
+    const Dict& operator[](const std::string& key) const
     {
         if (isNode())
         {
@@ -207,6 +310,7 @@ struct Dict
     Dict& operator=(const T& value)
     {
         data = value;
+        this->mark_modified_();
         return *this;
     }
 
@@ -214,7 +318,10 @@ struct Dict
     T& to()
     {
         if (std::holds_alternative<T>(data))
+        {
+            this->invalidate_hash_();
             return std::get<T>(data);
+        }
 
 #ifndef NDEBUG
         std::cout << __FILE__ << " " << __LINE__ << " " << currentKey << std::endl;
@@ -227,6 +334,7 @@ struct Dict
     {
         if (std::holds_alternative<T>(data))
         {
+            this->invalidate_hash_();
             return std::get<T>(data);
         }
         else if (isEmpty())
@@ -240,6 +348,26 @@ struct Dict
         throw std::runtime_error("cppdict: not a map or not default");
     }
 
+    template<typename T>
+    const T& to() const
+    {
+        if (std::holds_alternative<T>(data))
+            return std::get<T>(data);
+
+        throw std::runtime_error("cppdict: to<T> invalid type");
+    }
+
+    template<typename T>
+    T to(T defaultValue) const
+    {
+        if (std::holds_alternative<T>(data))
+            return std::get<T>(data);
+        else if (isEmpty())
+            return defaultValue;
+
+        throw std::runtime_error("cppdict: not a map or not default");
+    }
+
     bool contains(std::string const key) const noexcept
     {
         return isNode() and std::get<node_t>(data).count(key);
@@ -257,7 +385,10 @@ struct Dict
     decltype(auto) begin()
     {
         if (isNode())
+        {
+            this->invalidate_hash_(); // children may be replaced through the iterator
             return std::begin(std::get<node_t>(data));
+        }
         else
             throw std::runtime_error("cppdict: can't iterate this node");
     }
@@ -273,7 +404,10 @@ struct Dict
     decltype(auto) end()
     {
         if (isNode())
+        {
+            this->invalidate_hash_();
             return std::end(std::get<node_t>(data));
+        }
         else
             throw std::runtime_error("cppdict: can't iterate this node");
     }
@@ -300,31 +434,199 @@ struct Dict
         visit_impl<values_only_t>(*this, std::forward<Ts>(lambdas)...);
     }
 
+    /// Values are given by mutable reference, their hashes are recomputed on the next hash()
+    /// but versions aren't bumped, see touch().
+    template<class visit_policy_t, typename... Ts,
+             std::enable_if_t<is_visit_policy<visit_policy_t>::value, int> = 0>
+    void visit(visit_policy_t, Ts... lambdas)
+    {
+        visit_impl<visit_policy_t>(*this, std::forward<Ts>(lambdas)...);
+        this->invalidate_values_hashes_();
+    }
+
+    template<typename... Ts>
+    void visit(Ts... lambdas)
+    {
+        visit_impl<values_only_t>(*this, std::forward<Ts>(lambdas)...);
+        this->invalidate_values_hashes_();
+    }
+
+    /// Recursively visits every descendant, depth first. Unlike visit() the lambdas are
+    /// combined once and the values are passed by reference, so a visitor taking T& can
+    /// modify them in place. Visitors may return a visit_action to skip a subtree or stop.
+    /// Values given to a visitor which returns void and takes them by mutable reference are
+    /// marked modified, return visit_action::next or walk a const Dict to opt out.
+    template<class visit_policy_t, typename... Ts,
+             std::enable_if_t<is_visit_policy<visit_policy_t>::value, int> = 0>
+    void walk(visit_policy_t, Ts&&... lambdas)
+    {
+        walk_dict_<visit_policy_t>(*this, keep_all_t{}, lambdas...);
+    }
+
+    template<class visit_policy_t, typename... Ts,
+             std::enable_if_t<is_visit_policy<visit_policy_t>::value, int> = 0>
+    void walk(visit_policy_t, Ts&&... lambdas) const
+    {
+        walk_dict_<visit_policy_t>(*this, keep_all_t{}, lambdas...);
+    }
+
+    template<typename... Ts>
+    void walk(Ts&&... lambdas)
+    {
+        walk(visit_values_only, std::forward<Ts>(lambdas)...);
+    }
+
+    template<typename... Ts>
+    void walk(Ts&&... lambdas) const
+    {
+        walk(visit_values_only, std::forward<Ts>(lambdas)...);
+    }
+
+    /// Same as walk() but children for which keep(key) is false are neither visited nor
+    /// descended into.
+    template<class visit_policy_t, typename Pred, typename... Ts,
+             std::enable_if_t<is_visit_policy<visit_policy_t>::value, int> = 0>
+    void walk_if(visit_policy_t, Pred&& keep, Ts&&... lambdas)
+    {
+        walk_dict_<visit_policy_t>(*this, keep, lambdas...);
+    }
+
+    template<class visit_policy_t, typename Pred, typename... Ts,
+             std::enable_if_t<is_visit_policy<visit_policy_t>::value, int> = 0>
+    void walk_if(visit_policy_t, Pred&& keep, Ts&&... lambdas) const
+    {
+        walk_dict_<visit_policy_t>(*this, keep, lambdas...);
+    }
+
+    template<typename Pred, typename... Ts,
+             std::enable_if_t<!is_visit_policy<std::decay_t<Pred>>::value, int> = 0>
+    void walk_if(Pred&& keep, Ts&&... lambdas)
+    {
+        walk_if(visit_values_only, std::forward<Pred>(keep), std::forward<Ts>(lambdas)...);
+    }
+
+    template<typename Pred, typename... Ts,
+             std::enable_if_t<!is_visit_policy<std::decay_t<Pred>>::value, int> = 0>
+    void walk_if(Pred&& keep, Ts&&... lambdas) const
+    {
+        walk_if(visit_values_only, std::forward<Pred>(keep), std::forward<Ts>(lambdas)...);
+    }
+
     template<typename... Ts>
     void visit_leaves(Ts... lambdas) const
     {
+        visit_leaves_(*this, lambdas...);
+    }
+
+    /// Like visit(), leaves are given by mutable reference and their hashes invalidated.
+    template<typename... Ts>
+    void visit_leaves(Ts... lambdas)
+    {
+        visit_leaves_(*this, lambdas...);
+    }
+
+
+
+    /// Version stamp of the last modification of this node or of any of its descendants.
+    /// Stamps are taken from the root of the tree, so the root always holds the latest one.
+    version_t version() const noexcept { return version_; }
+
+    bool changed_since(version_t since) const noexcept { return version_ > since; }
+
+    /// Marks this node as modified, to be used after writing through a reference obtained
+    /// with to<T>() or from visit() since those can't be tracked.
+    void touch() { this->mark_modified_(); }
+
+    /// Structural hash of keys and values of this subtree. It is cached and, like versions,
+    /// only recomputed along modified paths. Handing out a mutable reference (to<T>(),
+    /// visit(), iterators) drops the cache of the node and its ancestors, so references
+    /// must not be written through after a later hash(), nor `data` written directly.
+    /// Not thread safe since it updates the cache.
+    std::size_t hash() const
+    {
+        if (hashed_version_ != version_)
+        {
+            hash_ = std::visit(
+                [](const auto& value) -> std::size_t {
+                    using T = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, node_t>)
+                    {
+                        auto seed = std::size(value);
+                        for (const auto& [key, child] : value)
+                            seed = hash_combine(hash_combine(seed, std::hash<std::string>{}(key)),
+                                                child->hash());
+                        return seed;
+                    }
+                    else if constexpr (std::is_same_v<T, empty_leaf_t>)
+                        return 0;
+                    else
+                        return value_hash<T>{}(value);
+                },
+                data);
+            hash_           = hash_combine(data.index(), hash_);
+            hashed_version_ = version_;
+        }
+        return hash_;
+    }
+
+    /// Deep comparison, shared subtrees are compared by address and, when Types... are
+    /// hashable, different hashes tell in O(1) that subtrees differ.
+    bool operator==(const Dict& other) const
+    {
+        if (this == &other)
+            return true;
+        if (data.index() != other.data.index())
+            return false;
+        if constexpr (is_hashable)
+            if (hash() != other.hash())
+                return false;
         if (isNode())
-            for (const auto& [_key, node] : std::get<node_t>(data))
-            {
-                const auto& key = _key;
-                if (node->isNode())
-                {
-                    node->visit_leaves(std::forward<Ts>(lambdas)...);
-                }
-                else if (node->isLeaf())
-                {
-                    std::visit(
-                        [key, lambdas...](auto&& value) { make_visitor(lambdas...)(key, value); },
-                        node->data);
-                }
-            }
-        else
-            throw std::runtime_error("cppdict: can only visit node");
+        {
+            auto const& children       = std::get<node_t>(data);
+            auto const& other_children = std::get<node_t>(other.data);
+            return std::equal(std::begin(children), std::end(children),
+                              std::begin(other_children), std::end(other_children),
+                              [](const auto& lhs, const auto& rhs) {
+                                  return lhs.first == rhs.first and *lhs.second == *rhs.second;
+                              });
+        }
+        return data == other.data;
+    }
+
+    bool operator!=(const Dict& other) const { return !(*this == other); }
+
+    /// Calls fn(path, node) for the deepest nodes modified after `since`, that is modified
+    /// nodes none of whose children were modified, only walking modified subtrees.
+    /// A node whose whole content was assigned after `since` is reported itself, so keys it
+    /// lost are covered. Paths are relative to this node and use '/' as delimiter.
+    template<typename Fn>
+    void visit_changes(version_t since, Fn&& fn) const
+    {
+        if (changed_since(since))
+            visit_changes_(since, std::string{}, fn);
     }
 
 
 
 private:
+    template<typename... Ts>
+    friend class ConcurrentDict;
+
+    static constexpr version_t no_version = std::numeric_limits<version_t>::max();
+
+    Dict* parent_                     = nullptr;
+    version_t version_                = 0;
+    mutable std::size_t hash_         = 0;
+    mutable version_t hashed_version_ = no_version;
+    version_t replaced_version_       = 0; // last time this whole node was assigned
+
+    // the cached hash stays valid when this node gets other's data
+    void copy_hash_(const Dict& other)
+    {
+        hash_           = other.hash_;
+        hashed_version_ = other.hashed_version_ == other.version_ ? version_ : no_version;
+    }
+
     void copy_data_()
     {
         if (isNode())
@@ -332,10 +634,199 @@ private:
             auto& my_data = std::get<node_t>(data);
             for (const auto& [key, value] : my_data)
             {
-                my_data[key] = std::make_shared<Dict>(*value.get());
+                my_data[key]          = std::make_shared<Dict>(*value.get());
+                my_data[key]->parent_ = this;
             }
         }
     }
+
+    void adopt_children_()
+    {
+        if (isNode())
+            for (auto& [_, child] : std::get<node_t>(data))
+                child->parent_ = this;
+    }
+
+    Dict& insert_child_(const std::string& key)
+    {
+        auto& child    = std::get<node_t>(data)[key];
+        child          = std::make_shared<Dict>();
+        child->parent_ = this;
+        child->mark_modified_();
+        return *child;
+    }
+
+    version_t next_version_() const noexcept
+    {
+        auto root = this;
+        while (root->parent_)
+            root = root->parent_;
+        return root->version_ + 1;
+    }
+
+    void mark_modified_()
+    {
+        auto const stamp = next_version_();
+        for (auto node = this; node; node = node->parent_)
+            node->version_ = stamp;
+    }
+
+    // a whole subtree was replaced, its stamps may come from another tree
+    void mark_subtree_modified_()
+    {
+        auto const stamp = next_version_();
+        stamp_subtree_(stamp);
+        replaced_version_ = stamp;
+        for (auto node = parent_; node; node = node->parent_)
+            node->version_ = stamp;
+    }
+
+    void stamp_subtree_(version_t stamp)
+    {
+        if (hashed_version_ == version_)
+            hashed_version_ = stamp;
+        version_          = stamp;
+        replaced_version_ = 0;
+        if (isNode())
+            for (auto& [_, child] : std::get<node_t>(data))
+                child->stamp_subtree_(stamp);
+    }
+
+    // Valid hashes only have valid descendants, so ancestors of an invalid node are invalid.
+    void invalidate_hash_() const noexcept
+    {
+        for (auto node = this; node and node->hashed_version_ == node->version_;
+             node = node->parent_)
+            node->hashed_version_ = no_version;
+    }
+
+    void invalidate_values_hashes_() const noexcept
+    {
+        for (const auto& [_, child] : std::get<node_t>(data))
+            if (child->isValue())
+                child->invalidate_hash_();
+    }
+
+    template<typename NodeT, typename... Ts>
+    static void visit_leaves_(NodeT& node, Ts&... lambdas)
+    {
+        using child_t = std::conditional_t<std::is_const_v<NodeT>, const Dict, Dict>;
+        if (!node.isNode())
+            throw std::runtime_error("cppdict: can only visit node");
+        for (const auto& [_key, child_ptr] : std::get<node_t>(node.data))
+        {
+            const auto& key = _key;
+            child_t& child  = *child_ptr;
+            if (child.isNode())
+                visit_leaves_(child, lambdas...);
+            else if (child.isLeaf())
+            {
+                std::visit(
+                    [key, lambdas...](auto&& value) { make_visitor(lambdas...)(key, value); },
+                    child.data);
+                if constexpr (!std::is_const_v<NodeT>)
+                    child.invalidate_hash_();
+            }
+        }
+    }
+
+    // marks this node and its ancestors, stopping at those which already got `stamp`
+    void stamp_up_(version_t stamp) noexcept
+    {
+        for (auto node = this; node and node->version_ != stamp; node = node->parent_)
+            node->version_ = stamp;
+    }
+
+    // All the values modified during a walk share one stamp, so each ancestor is only
+    // stamped once.
+    template<typename visit_policy_t, typename NodeT, typename Pred, typename... Ts>
+    static void walk_dict_(NodeT& node, Pred&& keep, Ts&... lambdas)
+    {
+        if (!node.isNode())
+            throw std::runtime_error("cppdict: can only visit node");
+        version_t stamp = 0;
+        if constexpr (!std::is_const_v<NodeT>)
+            stamp = node.next_version_();
+        if constexpr (sizeof...(Ts) == 1)
+            walk_children_<visit_policy_t>(node, keep, lambdas..., stamp);
+        else
+        {
+            auto visitor = make_visitor(lambdas...);
+            walk_children_<visit_policy_t>(node, keep, visitor, stamp);
+        }
+    }
+
+    // Everything is passed by reference so visitors are never copied while walking,
+    // returns false once the walk was stopped.
+    template<typename visit_policy_t, typename NodeT, typename Pred, typename VisitorT>
+    static bool walk_children_(NodeT& node, Pred& keep, VisitorT& visitor, version_t stamp)
+    {
+        using child_t = std::conditional_t<std::is_const_v<NodeT>, const Dict, Dict>;
+        for (const auto& [key, child_ptr] : std::get<node_t>(node.data))
+        {
+            if (!keep(key))
+                continue;
+            child_t& child = *child_ptr;
+            auto action    = visit_action::next;
+            if (!is_values_only_v<visit_policy_t> or child.isValue())
+            {
+                action = std::visit(
+                    [&key, &visitor](auto& value) {
+                        using T = std::decay_t<decltype(value)>;
+                        // only values can be modified, children maps are being iterated
+                        if constexpr (is_value_v<T>)
+                        {
+                            constexpr auto by_default
+                                = !std::is_const_v<NodeT> and takes_mutable_value<VisitorT, T>()
+                                      ? visit_action::modified
+                                      : visit_action::next;
+                            return invoke_visitor<by_default>(visitor, key, value);
+                        }
+                        else if constexpr (!is_values_only_v<visit_policy_t>)
+                            return invoke_visitor(visitor, key, std::as_const(value));
+                        else
+                            return visit_action::next;
+                    },
+                    child.data);
+            }
+            if (action == visit_action::stop)
+                return false;
+            if constexpr (!std::is_const_v<NodeT>)
+                if (action == visit_action::modified)
+                    child.stamp_up_(stamp);
+            if (action != visit_action::skip and child.isNode()
+                and !walk_children_<visit_policy_t>(child, keep, visitor, stamp))
+                return false;
+        }
+        return true;
+    }
+
+    // the content of a node of another tree was moved out, it is left empty
+    void moved_from_()
+    {
+        if (parent_)
+        {
+            data = empty_leaf_t{};
+            mark_subtree_modified_();
+        }
+    }
+
+    template<typename Fn>
+    void visit_changes_(version_t since, std::string const& path, Fn& fn) const
+    {
+        bool child_changed = false;
+        if (isNode() and replaced_version_ <= since)
+            for (const auto& [key, child] : std::get<node_t>(data))
+            {
+                if (child->changed_since(since))
+                {
+                    child_changed = true;
+                    child->visit_changes_(since, path.empty() ? key : path + '/' + key, fn);
+                }
+            }
+        if (!child_changed)
+            fn(path, *this);
+    }
 };
 
 namespace detail
@@ -410,4 +901,14 @@ T get_value(Dict<Types...> const& dict, std::string const& path, T const default
 
 
 } // namespace cppdict
+
+namespace std
+{
+template<typename... Types>
+struct hash<cppdict::Dict<Types...>>
+{
+    std::size_t operator()(const cppdict::Dict<Types...>& dict) const { return dict.hash(); }
+};
+} // namespace std
+
 #endif
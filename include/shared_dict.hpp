@@ -0,0 +1,521 @@
+#ifndef SHARED_DICT_H
+#define SHARED_DICT_H
+
+#include "dict.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cppdict
+{
+namespace detail
+{
+    // A frozen dict is a flat image where every reference is an offset from the beginning
+    // of the image, so it is valid wherever it is mapped.
+    struct frozen_header_t
+    {
+        std::uint64_t magic;
+        std::uint64_t signature;
+        std::uint64_t size;
+        std::uint64_t root;
+    };
+
+    // index follows Dict::data_t: 0 empty leaf, 1 node, 2 + i the ith user type.
+    // For nodes offset/count locate the children entries, for values the value bytes.
+    struct frozen_node_t
+    {
+        std::uint64_t index;
+        std::uint64_t offset;
+        std::uint64_t count;
+    };
+
+    struct frozen_entry_t
+    {
+        std::uint64_t key_offset;
+        std::uint64_t key_size;
+        std::uint64_t node;
+    };
+
+    inline constexpr std::uint64_t frozen_magic = 0x7463696470706300; // "\0cppdict"
+
+    // Values are copied bytewise into the image, a pointer would be meaningless in another
+    // process or mapping. Pointer members of trivially copyable structs can't be detected,
+    // such structs must not hold any.
+    template<typename T>
+    inline constexpr bool is_freezable_v
+        = std::is_same_v<T, std::string>
+          or (std::is_trivially_copyable_v<T> and !std::is_pointer_v<T>
+              and !std::is_member_pointer_v<T>);
+
+    template<typename T, typename... Types>
+    constexpr std::uint64_t index_of()
+    {
+        std::uint64_t index = 0;
+        bool found          = false;
+        ((found = found or std::is_same_v<T, Types>, index += found ? 0 : 1), ...);
+        return 2 + index;
+    }
+
+    // Images can only be read back with the same Types..., checked with a hash of their names
+    template<typename... Types>
+    std::uint64_t frozen_signature()
+    {
+        std::uint64_t hash = 14695981039346656037ull;
+        auto mix           = [&hash](std::string_view bytes) {
+            for (auto c : bytes)
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        };
+        ((mix(typeid(Types).name()), mix(std::to_string(sizeof(Types)))), ...);
+        return hash;
+    }
+
+    template<typename... Types>
+    class frozen_writer
+    {
+    public:
+        std::vector<std::byte> freeze(Dict<Types...> const& dict)
+        {
+            image_.clear();
+            auto header = allocate_(sizeof(frozen_header_t), alignof(frozen_header_t));
+            auto root   = write_node_(dict);
+            store_(header, frozen_header_t{frozen_magic, frozen_signature<Types...>(),
+                                           image_.size(), root});
+            return std::move(image_);
+        }
+
+    private:
+        std::vector<std::byte> image_;
+
+        std::uint64_t allocate_(std::size_t size, std::size_t alignment)
+        {
+            auto offset = (image_.size() + alignment - 1) / alignment * alignment;
+            image_.resize(offset + size);
+            return offset;
+        }
+
+        template<typename T>
+        void store_(std::uint64_t offset, T const& value)
+        {
+            std::memcpy(image_.data() + offset, &value, sizeof(T));
+        }
+
+        std::uint64_t write_bytes_(void const* bytes, std::size_t size, std::size_t alignment)
+        {
+            auto offset = allocate_(size, alignment);
+            if (size)
+                std::memcpy(image_.data() + offset, bytes, size);
+            return offset;
+        }
+
+        std::uint64_t write_node_(Dict<Types...> const& dict)
+        {
+            auto offset = allocate_(sizeof(frozen_node_t), alignof(frozen_node_t));
+            auto record = frozen_node_t{dict.data.index(), 0, 0};
+            std::visit(
+                [&](auto const& value) {
+                    using T = std::decay_t<decltype(value)>;
+                    if constexpr (std::is_same_v<T, typename Dict<Types...>::node_t>)
+                    {
+                        record.count  = value.size();
+                        record.offset = allocate_(record.count * sizeof(frozen_entry_t),
+                                                  alignof(frozen_entry_t));
+                        auto entry    = record.offset;
+                        for (auto const& [key, child] : value)
+                        {
+                            auto key_offset = write_bytes_(key.data(), key.size(), 1);
+                            auto node       = write_node_(*child);
+                            store_(entry, frozen_entry_t{key_offset, key.size(), node});
+                            entry += sizeof(frozen_entry_t);
+                        }
+                    }
+                    else if constexpr (std::is_same_v<T, std::string>)
+                    {
+                        record.offset = write_bytes_(value.data(), value.size(), 1);
+                        record.count  = value.size();
+                    }
+                    else if constexpr (Dict<Types...>::template is_value_v<T>)
+                    {
+                        record.offset = write_bytes_(&value, sizeof(T), alignof(T));
+                        record.count  = 1;
+                    }
+                },
+                dict.data);
+            store_(offset, record);
+            return offset;
+        }
+    };
+} // namespace detail
+
+
+/// Read only view on a frozen dict image, mirrors Dict read accessors.
+/// std::string values are returned as std::string_view pointing into the image.
+template<typename... Types>
+class FrozenDict
+{
+    template<typename T>
+    using value_ref_t
+        = std::conditional_t<std::is_same_v<T, std::string>, std::string_view, T const&>;
+
+public:
+    /// Returns a view on the root of an image built by freeze(), after checking it was
+    /// frozen with the same Types... Offsets are checked against `size` as the image is
+    /// walked, so a corrupted or truncated image throws instead of reading out of bounds.
+    static FrozenDict root(void const* image, std::size_t size)
+    {
+        auto bytes = static_cast<std::byte const*>(image);
+        check_(size >= sizeof(detail::frozen_header_t));
+        auto header = reinterpret_cast<detail::frozen_header_t const*>(bytes);
+        check_(header->magic == detail::frozen_magic and header->size <= size
+               and header->size >= sizeof(detail::frozen_header_t)
+               and header->root >= sizeof(detail::frozen_header_t));
+        if (header->signature != detail::frozen_signature<Types...>())
+            throw std::runtime_error("cppdict: frozen dict image has different types");
+        return FrozenDict{bytes, header->size, header->root};
+    }
+
+    FrozenDict operator[](std::string_view key) const
+    {
+        if (auto entry = find_(key))
+            return child_(*entry);
+        throw std::runtime_error("cppdict: invalid key: " + std::string{key});
+    }
+
+    bool contains(std::string_view key) const { return find_(key) != nullptr; }
+
+    bool isLeaf() const noexcept { return !isNode() && !isEmpty(); }
+
+    bool isNode() const noexcept { return node_->index == 1; }
+
+    bool isEmpty() const noexcept { return node_->index == 0; }
+
+    bool isValue() const noexcept { return !isNode() and !isEmpty(); }
+
+    std::size_t size() const noexcept
+    {
+        if (isNode())
+            return node_->count;
+        if (isEmpty())
+            return 0;
+        return 1;
+    }
+
+    template<typename T, typename Check = std::enable_if_t<is_any_of<T, Types...>()>>
+    value_ref_t<T> to() const
+    {
+        if (node_->index != detail::index_of<T, Types...>())
+            throw std::runtime_error("cppdict: to<T> invalid type");
+        if constexpr (std::is_same_v<T, std::string>)
+            return std::string_view{reinterpret_cast<char const*>(image_ + node_->offset),
+                                    node_->count};
+        else
+            return *reinterpret_cast<T const*>(image_ + node_->offset);
+    }
+
+    /// Copies this subtree back into a mutable Dict.
+    Dict<Types...> thaw() const
+    {
+        Dict<Types...> dict;
+        if (isNode())
+        {
+            if (node_->count == 0)
+                dict.data = typename Dict<Types...>::node_t{};
+            for (auto entry = entries_(); entry != entries_() + node_->count; ++entry)
+                dict[std::string{key_(*entry)}] = child_(*entry).thaw();
+        }
+        else if (isValue())
+            thaw_value_(dict, std::index_sequence_for<Types...>{});
+        return dict;
+    }
+
+private:
+    std::byte const* image_;
+    std::uint64_t size_;
+    detail::frozen_node_t const* node_;
+
+    // the record is checked here, entries keys and children when they are accessed
+    FrozenDict(std::byte const* image, std::uint64_t size, std::uint64_t node)
+        : image_{image}
+        , size_{size}
+        , node_{nullptr}
+    {
+        check_range_(node, sizeof(detail::frozen_node_t), alignof(detail::frozen_node_t));
+        node_ = reinterpret_cast<detail::frozen_node_t const*>(image + node);
+        check_(node_->index < 2 + sizeof...(Types));
+        if (isNode())
+        {
+            check_(node_->count <= size_ / sizeof(detail::frozen_entry_t));
+            check_range_(node_->offset, node_->count * sizeof(detail::frozen_entry_t),
+                         alignof(detail::frozen_entry_t));
+        }
+        else if (isValue())
+            check_value_(std::index_sequence_for<Types...>{});
+    }
+
+    static void check_(bool valid)
+    {
+        if (!valid)
+            throw std::runtime_error("cppdict: invalid frozen dict image");
+    }
+
+    void check_range_(std::uint64_t offset, std::uint64_t size, std::size_t alignment) const
+    {
+        check_(offset <= size_ and size <= size_ - offset and offset % alignment == 0);
+    }
+
+    template<typename T>
+    void check_value_() const
+    {
+        if constexpr (std::is_same_v<T, std::string>)
+            check_range_(node_->offset, node_->count, 1);
+        else
+            check_range_(node_->offset, sizeof(T), alignof(T));
+    }
+
+    template<std::size_t... I>
+    void check_value_(std::index_sequence<I...>) const
+    {
+        ((node_->index == 2 + I ? check_value_<Types>() : void()), ...);
+    }
+
+    detail::frozen_entry_t const* entries_() const noexcept
+    {
+        return reinterpret_cast<detail::frozen_entry_t const*>(image_ + node_->offset);
+    }
+
+    // children are always written after their parent, this also rules out cycles
+    FrozenDict child_(detail::frozen_entry_t const& entry) const
+    {
+        check_(entry.node > static_cast<std::uint64_t>(
+                   reinterpret_cast<std::byte const*>(node_) - image_));
+        return FrozenDict{image_, size_, entry.node};
+    }
+
+    std::string_view key_(detail::frozen_entry_t const& entry) const
+    {
+        check_range_(entry.key_offset, entry.key_size, 1);
+        return {reinterpret_cast<char const*>(image_ + entry.key_offset), entry.key_size};
+    }
+
+    // children are stored in std::map order, so sorted by key
+    detail::frozen_entry_t const* find_(std::string_view key) const
+    {
+        if (!isNode())
+            return nullptr;
+        auto first = entries_(), last = entries_() + node_->count;
+        auto entry = std::lower_bound(first, last, key, [this](auto const& candidate, auto k) {
+            return key_(candidate) < k;
+        });
+        if (entry != last and key_(*entry) == key)
+            return entry;
+        return nullptr;
+    }
+
+    template<std::size_t... I>
+    void thaw_value_(Dict<Types...>& dict, std::index_sequence<I...>) const
+    {
+        ((node_->index == 2 + I ? (void)(dict = Types{to<Types>()}) : void()), ...);
+    }
+};
+
+
+/// Serializes dict into a position independent image that FrozenDict can read.
+template<typename... Types>
+std::vector<std::byte> freeze(Dict<Types...> const& dict)
+{
+    static_assert((detail::is_freezable_v<Types> and ...),
+                  "cppdict: only std::string and trivially copyable types other than "
+                  "pointers can be frozen");
+    return detail::frozen_writer<Types...>{}.freeze(dict);
+}
+
+
+/// Frozen dict placed in a POSIX shared memory segment or a memory mapped file, so that
+/// processes on the same host share a single copy. The creator of a shared memory segment
+/// owns it and unlinks it on destruction, processes that attach to it only map it read only.
+template<typename... Types>
+class SharedDict
+{
+public:
+    SharedDict(SharedDict&& other) noexcept
+        : name_{std::move(other.name_)}
+        , address_{std::exchange(other.address_, nullptr)}
+        , size_{std::exchange(other.size_, 0)}
+        , owner_{std::exchange(other.owner_, false)}
+    {
+    }
+
+    SharedDict(SharedDict const&) = delete;
+    SharedDict& operator=(SharedDict const&) = delete;
+    SharedDict& operator=(SharedDict&&) = delete;
+
+    ~SharedDict()
+    {
+        if (address_)
+            ::munmap(address_, size_);
+        if (owner_)
+            ::shm_unlink(name_.c_str());
+    }
+
+    /// Freezes dict in a new shared memory segment, `name` follows shm_open rules ("/name").
+    /// The segment is visible under `name` before its content is written, the image magic is
+    /// written last so that attach() can detect it.
+    static SharedDict create(std::string const& name, Dict<Types...> const& dict)
+    {
+        auto image = freeze(dict);
+        auto fd    = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1)
+            throw_errno_("shm_open", name);
+        SharedDict shared{name, true};
+        shared.write_(fd, image);
+        return shared;
+    }
+
+    /// Maps read only a segment created by another process with create().
+    /// Throws "cppdict: shared dict not ready: <name>" while create() is still writing it,
+    /// callers can either retry or synchronize with the creator (e.g. with an MPI barrier).
+    static SharedDict attach(std::string const& name)
+    {
+        auto fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd == -1)
+            throw_errno_("shm_open", name);
+        SharedDict shared{name, false};
+        shared.map_(fd);
+        if (!shared.ready_())
+            throw std::runtime_error("cppdict: shared dict not ready: " + name);
+        return shared;
+    }
+
+    /// Writes a frozen dict to a file that open() can map. The file is written under a
+    /// temporary name then renamed, so it never appears partially written.
+    static void save(std::string const& path, Dict<Types...> const& dict)
+    {
+        auto image = freeze(dict);
+        auto tmp   = path + ".XXXXXX";
+        auto fd    = ::mkstemp(tmp.data());
+        if (fd == -1)
+            throw_errno_("mkstemp", path);
+        try
+        {
+            if (::fchmod(fd, 0644) == -1)
+            {
+                ::close(fd);
+                throw_errno_("fchmod", tmp);
+            }
+            SharedDict{tmp, false}.write_(fd, image);
+            if (::rename(tmp.c_str(), path.c_str()) == -1)
+                throw_errno_("rename", tmp);
+        }
+        catch (...)
+        {
+            ::unlink(tmp.c_str());
+            throw;
+        }
+    }
+
+    /// Maps read only a file written by save().
+    static SharedDict open(std::string const& path)
+    {
+        auto fd = ::open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+            throw_errno_("open", path);
+        SharedDict shared{path, false};
+        shared.map_(fd);
+        return shared;
+    }
+
+    FrozenDict<Types...> root() const { return FrozenDict<Types...>::root(address_, size_); }
+
+private:
+    std::string name_;
+    void* address_    = nullptr;
+    std::size_t size_ = 0;
+    bool owner_       = false;
+
+    SharedDict(std::string name, bool owner)
+        : name_{std::move(name)}
+        , owner_{owner}
+    {
+    }
+
+    [[noreturn]] static void throw_errno_(std::string const& function, std::string const& name)
+    {
+        throw std::runtime_error("cppdict: " + function + " failed for " + name + ": "
+                                 + std::strerror(errno));
+    }
+
+    // fd is closed in any case, the mapping stays valid
+    void write_(int fd, std::vector<std::byte> const& image)
+    {
+        if (::ftruncate(fd, static_cast<off_t>(image.size())) == -1)
+        {
+            ::close(fd);
+            throw_errno_("ftruncate", name_);
+        }
+        address_ = ::mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address_ == MAP_FAILED)
+        {
+            address_ = nullptr;
+            throw_errno_("mmap", name_);
+        }
+        size_ = image.size();
+        // the magic goes last, readers check it before anything else
+        auto constexpr magic_size = sizeof(detail::frozen_header_t::magic);
+        std::memcpy(static_cast<std::byte*>(address_) + magic_size, image.data() + magic_size,
+                    size_ - magic_size);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(address_, image.data(), magic_size);
+        ::mprotect(address_, size_, PROT_READ);
+    }
+
+    bool ready_() const
+    {
+        if (size_ < sizeof(detail::frozen_header_t))
+            return false;
+        std::uint64_t magic;
+        std::memcpy(&magic, address_, sizeof(magic));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return magic == detail::frozen_magic;
+    }
+
+    void map_(int fd)
+    {
+        struct stat status;
+        if (::fstat(fd, &status) == -1)
+        {
+            ::close(fd);
+            throw_errno_("fstat", name_);
+        }
+        size_ = static_cast<std::size_t>(status.st_size);
+        if (size_ == 0) // not truncated yet by create()
+        {
+            ::close(fd);
+            return;
+        }
+        address_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (address_ == MAP_FAILED)
+        {
+            address_ = nullptr;
+            throw_errno_("mmap", name_);
+        }
+    }
+};
+
+} // namespace cppdict
+#endif
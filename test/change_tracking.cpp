@@ -0,0 +1,138 @@
+// #define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "dict.hpp"
+using Dict = cppdict::Dict<int, double, std::string>;
+
+TEST_CASE("Mutations propagate versions up to the root", "[cppdict::Dict change tracking]")
+{
+    Dict dict;
+    dict["a"]["b"] = 1;
+    dict["c"]["d"] = 2.;
+    auto const v   = dict.version();
+
+    SECTION("Lookups don't change versions")
+    {
+        REQUIRE(dict["a"]["b"].to<int>() == 1);
+        REQUIRE_FALSE(dict.changed_since(v));
+    }
+    SECTION("Assigning a value marks the node and its ancestors only")
+    {
+        dict["a"]["b"] = 3;
+        REQUIRE(dict.changed_since(v));
+        REQUIRE(dict["a"].changed_since(v));
+        REQUIRE(dict["a"]["b"].changed_since(v));
+        REQUIRE_FALSE(dict["c"].changed_since(v));
+        REQUIRE_FALSE(dict["c"]["d"].changed_since(v));
+    }
+    SECTION("Inserting a key is a modification")
+    {
+        dict["c"]["e"];
+        REQUIRE(dict["c"].changed_since(v));
+        REQUIRE_FALSE(dict["a"].changed_since(v));
+    }
+    SECTION("add() is tracked")
+    {
+        cppdict::add("c/d", 4., dict);
+        REQUIRE(dict["c"]["d"].changed_since(v));
+        REQUIRE_FALSE(dict["a"].changed_since(v));
+    }
+    SECTION("Assigning a subtree marks the whole subtree")
+    {
+        Dict other;
+        other["x"]["y"] = 5;
+        dict["a"]       = other;
+        REQUIRE(dict["a"]["x"]["y"].changed_since(v));
+        REQUIRE_FALSE(dict["c"].changed_since(v));
+    }
+    SECTION("Writes through references must be touched")
+    {
+        dict["a"]["b"].to<int>() = 10;
+        REQUIRE_FALSE(dict.changed_since(v));
+        dict["a"]["b"].touch();
+        REQUIRE(dict["a"]["b"].changed_since(v));
+        REQUIRE(dict.changed_since(v));
+    }
+}
+
+TEST_CASE("Moved and copied dicts keep tracking", "[cppdict::Dict change tracking]")
+{
+    Dict dict;
+    dict["a"]["b"] = 1;
+    Dict moved{std::move(dict)};
+    auto const v    = moved.version();
+    moved["a"]["b"] = 2;
+    REQUIRE(moved.changed_since(v));
+
+    Dict copy      = moved;
+    auto const v2  = copy.version();
+    copy["a"]["b"] = 3;
+    REQUIRE(copy.changed_since(v2));
+    REQUIRE(moved["a"]["b"].to<int>() == 2);
+
+    Dict other;
+    other["x"]["y"] = 4;
+    auto const v3   = other.version();
+    copy["a"]       = std::move(other["x"]);
+    REQUIRE(copy["a"]["y"].to<int>() == 4);
+    REQUIRE(other["x"].isEmpty());
+    REQUIRE(other.changed_since(v3));
+    REQUIRE(other["x"].changed_since(v3));
+
+    REQUIRE(std::is_nothrow_move_constructible_v<Dict>);
+    REQUIRE(std::is_nothrow_move_assignable_v<Dict>);
+}
+
+TEST_CASE("Can walk only modified paths", "[cppdict::Dict change tracking]")
+{
+    Dict dict;
+    dict["a"]["b"]      = 1;
+    dict["a"]["c"]      = 2;
+    dict["d"]["e"]["f"] = 3.;
+    auto const v        = dict.version();
+
+    dict["a"]["c"]      = 4;
+    dict["d"]["e"]["g"] = std::string{"new"};
+
+    std::vector<std::string> paths;
+    dict.visit_changes(v,
+                       [&paths](std::string const& path, Dict const&) { paths.push_back(path); });
+    REQUIRE(paths == std::vector<std::string>{"a/c", "d/e/g"});
+
+    paths.clear();
+    dict.visit_changes(dict.version(),
+                       [&paths](std::string const& path, Dict const&) { paths.push_back(path); });
+    REQUIRE(paths.empty());
+
+}
+
+TEST_CASE("Assigned nodes are reported so removed keys aren't missed",
+          "[cppdict::Dict change tracking]")
+{
+    Dict dict;
+    dict["a"]["b"] = 1;
+    dict["a"]["c"] = 2;
+    auto const v   = dict.version();
+
+    Dict replacement;
+    replacement["b"] = 1;
+    dict["a"]        = replacement;
+
+    std::vector<std::string> paths;
+    dict.visit_changes(v,
+                       [&paths](std::string const& path, Dict const&) { paths.push_back(path); });
+    REQUIRE(paths == std::vector<std::string>{"a"});
+
+    auto const v2  = dict.version();
+    dict["a"]["b"] = 3;
+    paths.clear();
+    dict.visit_changes(v2,
+                       [&paths](std::string const& path, Dict const&) { paths.push_back(path); });
+    REQUIRE(paths == std::vector<std::string>{"a/b"});
+}
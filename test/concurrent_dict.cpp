@@ -0,0 +1,176 @@
+// #define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_dict.hpp"
+using ConcurrentDict = cppdict::ConcurrentDict<int, double, std::string>;
+using Dict           = ConcurrentDict::dict_t;
+
+TEST_CASE("Snapshots are immutable versions", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    cdict.add("a/b", 1);
+    cdict.add("c/d", 2.);
+    auto const before = cdict.snapshot();
+
+    cdict.add("a/b", 3);
+    auto const after = cdict.snapshot();
+
+    REQUIRE((*before)["a"]["b"].to<int>() == 1);
+    REQUIRE((*after)["a"]["b"].to<int>() == 3);
+    REQUIRE((*after)["c"]["d"].to<double>() == 2.);
+    REQUIRE(after->changed_since(before->version()));
+    REQUIRE_FALSE((*after)["c"].changed_since(before->version()));
+}
+
+TEST_CASE("Unchanged subtrees are shared between versions", "[cppdict::ConcurrentDict]")
+{
+    Dict dict;
+    dict["a"]["b"] = 1;
+    dict["c"]["d"] = 2.;
+    ConcurrentDict cdict{dict};
+    auto const before = cdict.snapshot();
+
+    cdict.update("a", [](Dict& node) { node["e"] = std::string{"new"}; });
+    auto const after = cdict.snapshot();
+
+    REQUIRE(&(*before)["c"] == &(*after)["c"]);
+    REQUIRE(&(*before)["a"] != &(*after)["a"]);
+    REQUIRE_FALSE((*before)["a"].contains("e"));
+    REQUIRE((*after)["a"]["e"].to<std::string>() == "new");
+    REQUIRE((*after)["a"]["b"].to<int>() == 1);
+}
+
+TEST_CASE("Identical subtrees can be deduplicated", "[cppdict::ConcurrentDict]")
+{
+    Dict dict;
+    for (auto const& name : {"a", "b", "c"})
+    {
+        dict[name]["solver"]["tolerance"] = 1e-6;
+        dict[name]["solver"]["max_iter"]  = 100;
+    }
+    dict["c"]["solver"]["max_iter"] = 10;
+    ConcurrentDict cdict{dict};
+    cdict.deduplicate();
+    auto const before = cdict.snapshot();
+
+    REQUIRE(*before == dict);
+    REQUIRE(&(*before)["a"] == &(*before)["b"]);
+    REQUIRE(&(*before)["a"] != &(*before)["c"]);
+    REQUIRE(&(*before)["a"]["solver"]["tolerance"] == &(*before)["c"]["solver"]["tolerance"]);
+
+    cdict.add("a/solver/max_iter", 1000);
+    auto const after = cdict.snapshot();
+    REQUIRE((*after)["a"]["solver"]["max_iter"].to<int>() == 1000);
+    REQUIRE((*after)["b"]["solver"]["max_iter"].to<int>() == 100);
+    REQUIRE((*before)["a"]["solver"]["max_iter"].to<int>() == 100);
+}
+
+TEST_CASE("Shared nodes don't point into freed versions", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    cdict.add("a/b", 1);
+    cdict.add("c/d", 2);
+    cdict.add("a/b", 3);
+    auto const snap = cdict.snapshot();
+    auto const v    = snap->version();
+    // not allowed, but must not follow a dangling parent link
+    std::begin((*snap)["c"])->second->touch();
+    REQUIRE_FALSE(snap->changed_since(v));
+}
+
+TEST_CASE("Reset never goes back in versions", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    for (int i = 0; i < 50; ++i)
+        cdict.add("a/b", i);
+    auto const v = cdict.snapshot()->version();
+
+    Dict dict;
+    dict["c"] = 1;
+    cdict.reset(dict);
+    auto const snap = cdict.snapshot();
+    REQUIRE(snap->changed_since(v));
+    REQUIRE((*snap)["c"].changed_since(v));
+    std::vector<std::string> paths;
+    snap->visit_changes(v, [&paths](std::string const& path, Dict const&) {
+        paths.push_back(path);
+    });
+    REQUIRE(paths == std::vector<std::string>{""});
+}
+
+TEST_CASE("Deduplication keeps the latest versions", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    cdict.add("a/solver/tol", 1);
+    cdict.add("b/solver/tol", 2);
+    auto const v = cdict.snapshot()->version();
+    cdict.add("b/solver/tol", 1);
+    cdict.deduplicate();
+    auto const snap = cdict.snapshot();
+
+    REQUIRE(&(*snap)["a"] == &(*snap)["b"]);
+    REQUIRE((*snap)["b"].changed_since(v));
+    REQUIRE((*snap)["b"]["solver"].changed_since(v));
+    std::vector<std::string> paths;
+    snap->visit_changes(v, [&paths](std::string const& path, Dict const&) {
+        paths.push_back(path);
+    });
+    REQUIRE(std::find(std::begin(paths), std::end(paths), "b/solver/tol") != std::end(paths));
+}
+
+TEST_CASE("Types don't need to be hashable", "[cppdict::ConcurrentDict]")
+{
+    cppdict::ConcurrentDict<int, std::vector<int>> cdict;
+    cdict.add("a", std::vector<int>{1, 2});
+    cdict.update("a", [](auto& node) { node.template to<std::vector<int>>().push_back(3); });
+    REQUIRE((*cdict.snapshot())["a"].to<std::vector<int>>().size() == 3);
+}
+
+TEST_CASE("Updating through a leaf throws", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    cdict.add("a", 1);
+    REQUIRE_THROWS_WITH(cdict.add("a/b", 2), "cppdict: invalid key: b");
+    REQUIRE((*cdict.snapshot())["a"].to<int>() == 1);
+}
+
+TEST_CASE("Readers always see a consistent tree", "[cppdict::ConcurrentDict]")
+{
+    ConcurrentDict cdict;
+    cdict.update("", [](Dict& root) {
+        root["a"]["x"] = 0;
+        root["b"]["y"] = 0;
+    });
+
+    std::thread writer{[&cdict] {
+        for (int i = 1; i <= 1000; ++i)
+            cdict.update("", [i](Dict& root) {
+                root["a"]["x"] = i;
+                root["b"]["y"] = i;
+            });
+    }};
+    std::atomic<bool> consistent = true;
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 2; ++r)
+        readers.emplace_back([&cdict, &consistent] {
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto const snap = cdict.snapshot();
+                if ((*snap)["a"]["x"].to<int>() != (*snap)["b"]["y"].to<int>())
+                    consistent = false;
+            }
+        });
+    writer.join();
+    for (auto& reader : readers)
+        reader.join();
+    REQUIRE(consistent);
+    REQUIRE((*cdict.snapshot())["a"]["x"].to<int>() == 1000);
+}
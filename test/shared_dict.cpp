@@ -0,0 +1,147 @@
+// #define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "shared_dict.hpp"
+using Dict       = cppdict::Dict<int, double, std::string>;
+using SharedDict = cppdict::SharedDict<int, double, std::string>;
+using FrozenDict = cppdict::FrozenDict<int, double, std::string>;
+
+namespace
+{
+Dict make_dict()
+{
+    Dict dict;
+    dict["first"]                       = 3.14;
+    dict["second"]                      = 1;
+    dict["third"]["level2"]             = std::string{"hello"};
+    dict["third"]["level2_2"]["level3"] = 33;
+    dict["empty"];
+    return dict;
+}
+} // namespace
+
+TEST_CASE("Frozen dicts can be read back", "[cppdict::FrozenDict]")
+{
+    auto const image = cppdict::freeze(make_dict());
+    auto const root  = FrozenDict::root(image.data(), image.size());
+
+    REQUIRE(root.isNode());
+    REQUIRE(root.size() == 4);
+    REQUIRE(root["first"].to<double>() == 3.14);
+    REQUIRE(root["second"].to<int>() == 1);
+    REQUIRE(root["third"]["level2"].to<std::string>() == "hello");
+    REQUIRE(root["third"]["level2_2"]["level3"].to<int>() == 33);
+    REQUIRE(root["empty"].isEmpty());
+    REQUIRE(root["third"].contains("level2"));
+    REQUIRE_FALSE(root.contains("fourth"));
+    REQUIRE_THROWS_WITH(root["fourth"], "cppdict: invalid key: fourth");
+    REQUIRE_THROWS_WITH(root["first"].to<int>(), "cppdict: to<T> invalid type");
+
+    auto const dict = root.thaw();
+    REQUIRE(dict["third"]["level2_2"]["level3"].to<int>() == 33);
+    REQUIRE(dict["empty"].isEmpty());
+}
+
+TEST_CASE("Frozen images are checked", "[cppdict::FrozenDict]")
+{
+    auto const image = cppdict::freeze(make_dict());
+    REQUIRE_THROWS_WITH((cppdict::FrozenDict<int, double>::root(image.data(), image.size())),
+                        "cppdict: frozen dict image has different types");
+    REQUIRE_THROWS_WITH(FrozenDict::root(image.data(), 8), "cppdict: invalid frozen dict image");
+
+    REQUIRE(cppdict::detail::is_freezable_v<double>);
+    REQUIRE_FALSE(cppdict::detail::is_freezable_v<int*>);
+    REQUIRE_FALSE(cppdict::detail::is_freezable_v<int Dict::*>);
+}
+
+TEST_CASE("Corrupted frozen images are rejected", "[cppdict::FrozenDict]")
+{
+    auto image = cppdict::freeze(make_dict());
+
+    SECTION("Truncated image with a consistent header")
+    {
+        auto const truncated = image.size() / 2;
+        std::memcpy(image.data() + offsetof(cppdict::detail::frozen_header_t, size), &truncated,
+                    sizeof(truncated));
+        auto const walk = [&] {
+            auto const root = FrozenDict::root(image.data(), truncated);
+            return root.thaw();
+        };
+        REQUIRE_THROWS_WITH(walk(), "cppdict: invalid frozen dict image");
+    }
+    SECTION("Root offset out of the image")
+    {
+        std::uint64_t const root = image.size();
+        std::memcpy(image.data() + offsetof(cppdict::detail::frozen_header_t, root), &root,
+                    sizeof(root));
+        REQUIRE_THROWS_WITH(FrozenDict::root(image.data(), image.size()),
+                            "cppdict: invalid frozen dict image");
+    }
+    SECTION("Child pointing back to an ancestor")
+    {
+        using cppdict::detail::frozen_entry_t;
+        using cppdict::detail::frozen_header_t;
+        using cppdict::detail::frozen_node_t;
+        frozen_header_t header;
+        frozen_node_t root;
+        std::memcpy(&header, image.data(), sizeof(header));
+        std::memcpy(&root, image.data() + header.root, sizeof(root));
+        std::memcpy(image.data() + root.offset + offsetof(frozen_entry_t, node), &header.root,
+                    sizeof(header.root));
+
+        auto const frozen = FrozenDict::root(image.data(), image.size());
+        REQUIRE_THROWS_WITH(frozen.thaw(), "cppdict: invalid frozen dict image");
+    }
+}
+
+TEST_CASE("Shared memory dicts can be attached read only", "[cppdict::SharedDict]")
+{
+    auto const name = "/cppdict_test_" + std::to_string(::getpid());
+    auto owner      = SharedDict::create(name, make_dict());
+    auto attached   = SharedDict::attach(name);
+
+    REQUIRE(attached.root()["third"]["level2"].to<std::string>() == "hello");
+    REQUIRE(&owner.root()["second"].to<int>() != &attached.root()["second"].to<int>());
+    REQUIRE_THROWS(SharedDict::create(name, make_dict()));
+}
+
+TEST_CASE("Attaching a segment being created throws", "[cppdict::SharedDict]")
+{
+    auto const name = "/cppdict_test_partial_" + std::to_string(::getpid());
+    auto fd         = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    REQUIRE(fd != -1);
+    REQUIRE_THROWS_WITH(SharedDict::attach(name), "cppdict: shared dict not ready: " + name);
+    REQUIRE(::ftruncate(fd, 4096) == 0);
+    REQUIRE_THROWS_WITH(SharedDict::attach(name), "cppdict: shared dict not ready: " + name);
+    ::close(fd);
+    ::shm_unlink(name.c_str());
+}
+
+TEST_CASE("Frozen dicts can be mapped from files", "[cppdict::SharedDict]")
+{
+    auto const path = "cppdict_test_" + std::to_string(::getpid()) + ".bin";
+    SharedDict::save(path, make_dict());
+    {
+        auto mapped = SharedDict::open(path);
+        REQUIRE(mapped.root()["first"].to<double>() == 3.14);
+    }
+    SECTION("Truncated files are rejected")
+    {
+        auto const size = ::truncate(path.c_str(), 200);
+        REQUIRE(size == 0);
+        auto mapped = SharedDict::open(path);
+        REQUIRE_THROWS_WITH(mapped.root(), "cppdict: invalid frozen dict image");
+    }
+    std::remove(path.c_str());
+    REQUIRE_THROWS(SharedDict::open(path));
+}
@@ -1,6 +1,8 @@
 // #define CATCH_CONFIG_MAIN
 
 #include <numeric> // std::accumulate
+#include <type_traits>
+#include <vector>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers.hpp>
@@ -150,3 +152,130 @@ TEST_CASE("Visit leaves", "[cppdict::Dict<int, double, std::string> stl_compat>]
         REQUIRE(string_count == 1UL);
     }
 }
+
+namespace
+{
+struct counting_visitor
+{
+    std::size_t count = 0;
+    template<typename T>
+    void operator()(const std::string&, const T&)
+    {
+        count++;
+    }
+};
+} // namespace
+
+TEST_CASE("Walk nodes", "[cppdict::Dict<int, double, std::string> stl_compat>]")
+{
+    Dict dict;
+    dict["first"]                       = 3.14;
+    dict["second"]                      = 1;
+    dict["third"]["level2"]             = std::string{"hello"};
+    dict["third"]["level2_2"]           = .2;
+    dict["third"]["level2_3"]           = 55;
+    dict["third"]["level2_4"]["level3"] = 33;
+    dict["empty"];
+    SECTION("By default only values are visited, recursively")
+    {
+        auto int_count    = 0UL;
+        auto double_count = 0UL;
+        auto string_count = 0UL;
+        dict.walk([&double_count](const std::string&, double) { double_count++; },
+                  [&int_count](const std::string&, int) { int_count++; },
+                  [&string_count](const std::string&, const std::string&) { string_count++; });
+        REQUIRE(int_count == 3UL);
+        REQUIRE(double_count == 2UL);
+        REQUIRE(string_count == 1UL);
+    }
+    SECTION("A single visitor is not copied")
+    {
+        counting_visitor visitor;
+        dict.walk(cppdict::visit_all_nodes, visitor);
+        REQUIRE(visitor.count == 9UL);
+    }
+    SECTION("Visitors can skip subtrees")
+    {
+        auto count = 0UL;
+        dict.walk(
+            cppdict::visit_all_nodes,
+            [](const std::string&, const Dict::node_t&) { return cppdict::visit_action::skip; },
+            [&count](const std::string&, const auto&) { count++; });
+        REQUIRE(count == 3UL);
+    }
+    SECTION("Visitors can stop the walk")
+    {
+        std::vector<std::string> keys;
+        dict.walk(cppdict::visit_values_only, [&keys](const std::string& key, const auto&) {
+            keys.push_back(key);
+            return key == "level2" ? cppdict::visit_action::stop : cppdict::visit_action::next;
+        });
+        REQUIRE(keys == std::vector<std::string>{"first", "second", "level2"});
+    }
+    SECTION("Subtrees can be pruned by key")
+    {
+        auto count = 0UL;
+        dict.walk_if(
+            cppdict::visit_values_only, [](const std::string& key) { return key != "third"; },
+            [&count](const std::string&, const auto&) { count++; });
+        REQUIRE(count == 2UL);
+    }
+    SECTION("Pruning defaults to values only")
+    {
+        auto count = 0UL;
+        dict.walk_if([](const std::string& key) { return key != "level2_4"; },
+                     [&count](const std::string&, const auto&) { count++; });
+        REQUIRE(count == 5UL);
+    }
+    SECTION("Nodes are never given as mutable, only values")
+    {
+        auto mutable_nodes  = 0UL;
+        auto mutable_values = 0UL;
+        dict.walk(cppdict::visit_all_nodes, [&](const std::string&, auto& value) {
+            using T = std::remove_reference_t<decltype(value)>;
+            if constexpr (!std::is_const_v<T>)
+            {
+                if constexpr (Dict::is_value_v<std::remove_const_t<T>>)
+                    mutable_values++;
+                else
+                    mutable_nodes++;
+            }
+        });
+        REQUIRE(mutable_nodes == 0UL);
+        REQUIRE(mutable_values == 6UL);
+    }
+    SECTION("Visitors can modify values in place")
+    {
+        auto const version = dict.version();
+        dict.walk([](const std::string&, int& value) { value *= 2; },
+                  [](const std::string&, const auto&) {});
+        REQUIRE(dict["second"].to<int>() == 2);
+        REQUIRE(dict["third"]["level2_4"]["level3"].to<int>() == 66);
+        REQUIRE(dict["second"].changed_since(version));
+        REQUIRE(dict["third"]["level2_4"]["level3"].changed_since(version));
+        REQUIRE_FALSE(dict["first"].changed_since(version));
+
+        auto const version2 = dict.version();
+        dict.walk([](const std::string&, const auto&) {});
+        dict.walk([](const std::string&, auto& value) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(value)>, int>)
+                value += 0;
+            return cppdict::visit_action::next;
+        });
+        REQUIRE_FALSE(dict.changed_since(version2));
+
+        dict.walk([](const std::string&, int& value) {
+                      value += 1;
+                      return cppdict::visit_action::modified;
+                  },
+                  [](const std::string&, const auto&) { return cppdict::visit_action::next; });
+        REQUIRE(dict["second"].to<int>() == 3);
+        REQUIRE(dict["third"]["level2_4"]["level3"].changed_since(version2));
+        REQUIRE_FALSE(dict["first"].changed_since(version2));
+    }
+    SECTION("Walking leaves is forbiden")
+    {
+        REQUIRE_THROWS_WITH(dict["first"].walk([](const std::string&, const auto&) {}),
+                            "cppdict: can only visit node");
+    }
+}
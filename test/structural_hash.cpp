@@ -0,0 +1,147 @@
+// #define CATCH_CONFIG_MAIN
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers.hpp>
+
+#include <string>
+#include <unordered_map>
+
+#include "dict.hpp"
+using Dict = cppdict::Dict<int, double, std::string>;
+
+namespace
+{
+Dict make_dict()
+{
+    Dict dict;
+    dict["first"]                       = 3.14;
+    dict["second"]                      = 1;
+    dict["third"]["level2"]             = std::string{"hello"};
+    dict["third"]["level2_2"]["level3"] = 33;
+    dict["empty"];
+    return dict;
+}
+
+struct Point
+{
+    int x, y;
+    bool operator==(const Point& other) const { return x == other.x and y == other.y; }
+};
+} // namespace
+
+namespace cppdict
+{
+template<>
+struct value_hash<Point>
+{
+    std::size_t operator()(const Point& p) const { return std::hash<int>{}(p.x * 31 + p.y); }
+};
+} // namespace cppdict
+
+TEST_CASE("Equal trees have equal hashes", "[cppdict::Dict hashing]")
+{
+    auto const dict = make_dict();
+    auto other      = make_dict();
+    REQUIRE(dict.hash() == other.hash());
+    REQUIRE(dict == other);
+    REQUIRE(dict["third"] == other["third"]);
+    REQUIRE(dict["first"] != dict["second"]);
+
+    SECTION("Hashes follow modifications")
+    {
+        other["third"]["level2_2"]["level3"] = 34;
+        REQUIRE(dict.hash() != other.hash());
+        REQUIRE(dict != other);
+        REQUIRE(dict["third"]["level2"] == other["third"]["level2"]);
+
+        other["third"]["level2_2"]["level3"] = 33;
+        REQUIRE(dict == other);
+    }
+    SECTION("Keys are part of the hash")
+    {
+        Dict renamed;
+        renamed["first"]                        = 3.14;
+        renamed["second"]                       = 1;
+        renamed["third"]["level2"]              = std::string{"hello"};
+        renamed["third"]["level2_2"]["level3b"] = 33;
+        renamed["empty"];
+        REQUIRE(dict != renamed);
+    }
+    SECTION("Types are part of the hash")
+    {
+        Dict lhs, rhs;
+        lhs["value"] = 1;
+        rhs["value"] = 1.;
+        REQUIRE(lhs != rhs);
+    }
+    SECTION("Copies keep equal hashes")
+    {
+        Dict copy;
+        copy["sub"] = dict["third"];
+        REQUIRE(copy["sub"] == dict["third"]);
+        REQUIRE(copy["sub"].hash() == dict["third"].hash());
+    }
+    SECTION("Writes through references are rehashed")
+    {
+        auto const hash           = other.hash();
+        other["second"].to<int>() = 2;
+        REQUIRE(dict != other);
+        REQUIRE(other.hash() != hash);
+
+        other.visit([](const std::string&, int& value) { value = 1; },
+                    [](const std::string&, const auto&) {});
+        REQUIRE(other.hash() == hash);
+        REQUIRE(dict == other);
+
+        other.visit_leaves([](const std::string&, int& value) { value += 1; },
+                           [](const std::string&, const auto&) {});
+        REQUIRE(other.hash() != hash);
+        REQUIRE(dict != other);
+    }
+}
+
+TEST_CASE("Equality doesn't depend on cached hashes", "[cppdict::Dict hashing]")
+{
+    Dict x, y;
+    x["k"] = 1;
+    y["k"] = 2;
+    x.hash();
+    x["k"].to<int>() = 2;
+    REQUIRE(x == y);
+}
+
+TEST_CASE("Dicts can be used as keys", "[cppdict::Dict hashing]")
+{
+    std::unordered_map<Dict, int> cache;
+    cache[make_dict()["third"]] = 42;
+    REQUIRE(cache.count(make_dict()["third"]) == 1);
+    REQUIRE(cache.count(make_dict()) == 0);
+
+    auto key = make_dict();
+    key.hash();
+    key["second"].to<int>() = 2;
+    auto expected           = make_dict();
+    expected["second"]      = 2;
+    cache[expected]         = 1;
+    REQUIRE(std::hash<Dict>{}(key) == std::hash<Dict>{}(expected));
+    REQUIRE(cache.at(key) == 1);
+}
+
+TEST_CASE("User types can provide their hash", "[cppdict::Dict hashing]")
+{
+    using PointDict = cppdict::Dict<int, Point>;
+    static_assert(PointDict::is_hashable);
+    PointDict lhs, rhs;
+    lhs["origin"] = Point{0, 0};
+    rhs["origin"] = Point{0, 0};
+    REQUIRE(lhs == rhs);
+    REQUIRE(lhs.hash() == rhs.hash());
+
+    std::unordered_map<PointDict, int> cache;
+    cache[lhs] = 1;
+    REQUIRE(cache.count(rhs) == 1);
+
+    rhs["origin"] = Point{1, 0};
+    REQUIRE(lhs != rhs);
+    REQUIRE(cache.count(rhs) == 0);
+}